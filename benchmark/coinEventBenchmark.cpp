@@ -0,0 +1,180 @@
+/*
+ * Developed for the VMachine industries.
+ * This product includes software developed by the VMachine industries.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Compares the events processed per second by coinEventQueue with
+ * the thread-per-device model, where each device blocks a thread
+ * around synchronous vendingMachine calls.
+ *
+ * Every machine serves customers paying £2 for a product costing
+ * £1.25: a coin acceptor deposits the coin and a payment terminal
+ * requests the sale, i.e. two events per customer.
+ */
+
+#include "../vendingMachine.h"
+#include "../coinEventQueue.h"
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <ctime>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+using namespace std;
+
+const float coinPaid = 2.00;
+const float price = 1.25;
+
+// Enough coins to give change to every customer
+vendingMachine buildVendMachine( unsigned int customers ) {
+  vector<unsigned int> quantities = {0, 0, customers, 0, customers, customers, 0, 0};
+  return vendingMachine( GBP, quantities );
+}
+
+void report( const char* model, unsigned long events, double wallSeconds, double cpuSeconds ) {
+  cout << model << ": " << events << " events in " << wallSeconds << " s, "
+       << events / wallSeconds << " events/s, "
+       << events / cpuSeconds << " events per CPU second" << endl;
+}
+
+void benchmarkEventQueue( unsigned int machineCount, unsigned int customers ) {
+  vector<vendingMachine> machines( machineCount, buildVendMachine( customers ) );
+  coinEventQueue queue( 64, 32 );
+  vector<unsigned int> coinsDeposited( machineCount, 0 );
+  vector<unsigned int> salesRequested( machineCount, 0 );
+  unsigned long failures = 0;
+
+  coinEventQueue::callback done = [&failures]( coinEventQueue::status result, const vector<coinValue>& ) {
+    failures += result != coinEventQueue::succeeded;
+  };
+
+  for ( unsigned int m = 0; m < machineCount; m++ )
+    queue.addMachine( machines[m] );
+
+  auto wallStart = chrono::steady_clock::now();
+  clock_t cpuStart = clock();
+  unsigned long events = 0;
+  bool submitting = true;
+
+  while ( submitting ) {
+    submitting = false;
+
+    // Devices submit events until their queue is full
+    for ( unsigned int m = 0; m < machineCount; m++ ) {
+      while ( salesRequested[m] < customers ) {
+        if ( coinsDeposited[m] == salesRequested[m] ) {
+          if ( !queue.addCoin( m, coinPaid, done ) )
+            break;
+          coinsDeposited[m]++;
+        } else {
+          if ( !queue.vend( m, price, done ) )
+            break;
+          salesRequested[m]++;
+        }
+      }
+
+      submitting = submitting || salesRequested[m] < customers;
+    }
+
+    events += queue.runOnce();
+  }
+
+  events += queue.run();
+
+  double wallSeconds = chrono::duration<double>( chrono::steady_clock::now() - wallStart ).count();
+  double cpuSeconds = double( clock() - cpuStart ) / CLOCKS_PER_SEC;
+
+  if ( failures > 0 )
+    cout << "ERROR: " << failures << " events failed." << endl;
+
+  report( "coinEventQueue (1 thread)", events, wallSeconds, cpuSeconds );
+}
+
+// The state shared by the device threads of one machine. The terminal
+// does the same credit accounting as a coinEventQueue vend event.
+struct sharedMachine {
+  vendingMachine machine;
+  mutex lock;
+  condition_variable creditChanged;
+  long creditCents;
+
+  sharedMachine( unsigned int customers ): machine( buildVendMachine( customers ) ), creditCents( 0 ) {}
+};
+
+void benchmarkThreadPerDevice( unsigned int machineCount, unsigned int customers ) {
+  const long priceCents = lround( price * 100 );
+
+  vector<sharedMachine*> machines;
+  for ( unsigned int m = 0; m < machineCount; m++ )
+    machines.push_back( new sharedMachine( customers ) );
+
+  auto wallStart = chrono::steady_clock::now();
+  clock_t cpuStart = clock();
+  vector<thread> threads;
+
+  for ( sharedMachine* shared : machines ) {
+    // Coin acceptor, blocked until the previous customer has been served
+    threads.emplace_back( [shared, customers]() {
+      for ( unsigned int i = 0; i < customers; i++ ) {
+        unique_lock<mutex> guard( shared->lock );
+        shared->creditChanged.wait( guard, [shared]() { return shared->creditCents == 0; } );
+        shared->machine.addCoin( coinPaid );
+        shared->creditCents += lround( coinPaid * 100 );
+        shared->creditChanged.notify_all();
+      }
+    } );
+
+    // Payment terminal, blocked until enough credit has been deposited
+    threads.emplace_back( [shared, customers, priceCents]() {
+      for ( unsigned int i = 0; i < customers; i++ ) {
+        unique_lock<mutex> guard( shared->lock );
+        shared->creditChanged.wait( guard, [shared, priceCents]() { return shared->creditCents >= priceCents; } );
+        shared->machine.computeChange( ( shared->creditCents - priceCents ) / 100.0f );
+        shared->creditCents = 0;
+        shared->creditChanged.notify_all();
+      }
+    } );
+  }
+
+  for ( thread& t : threads )
+    t.join();
+
+  double wallSeconds = chrono::duration<double>( chrono::steady_clock::now() - wallStart ).count();
+  double cpuSeconds = double( clock() - cpuStart ) / CLOCKS_PER_SEC;
+
+  for ( sharedMachine* shared : machines )
+    delete shared;
+
+  cout << threads.size() << " threads, ";
+  report( "thread per device", 2ul * machineCount * customers, wallSeconds, cpuSeconds );
+}
+
+int main( int argc, char* argv[] ) {
+  unsigned int machineCount = argc > 1 ? atoi( argv[1] ) : 4;
+  unsigned int customers = argc > 2 ? atoi( argv[2] ) : 200000;
+
+  cout << machineCount << " machines, " << customers << " customers per machine" << endl;
+
+  benchmarkEventQueue( machineCount, customers );
+  benchmarkThreadPerDevice( machineCount, customers );
+
+  return 0;
+}
@@ -0,0 +1,135 @@
+/*
+ * Developed for the VMachine industries.
+ * This product includes software developed by the VMachine industries.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "coinEventQueue.h"
+#include <vector>
+#include <utility>
+#include <cmath>
+#include <cassert>
+
+coinEventQueue::coinEventQueue( std::size_t capacity, std::size_t batchSize ):
+  capacity(capacity), batchSize(batchSize) {
+
+    assert( capacity > 0 && batchSize > 0 );
+  }
+
+std::size_t coinEventQueue::addMachine( vendingMachine& machine ) {
+  machineState state;
+  state.machine = &machine;
+  state.creditCents = 0;
+
+  machines.push_back( state );
+  return machines.size() - 1;
+}
+
+bool coinEventQueue::addCoin( std::size_t machine, coinValue coin, const callback& done ) {
+  return submit( machine, addCoinEvent, coin, done );
+}
+
+bool coinEventQueue::computeChange( std::size_t machine, float change, const callback& done ) {
+  return submit( machine, computeChangeEvent, change, done );
+}
+
+bool coinEventQueue::vend( std::size_t machine, float price, const callback& done ) {
+  return submit( machine, vendEvent, price, done );
+}
+
+bool coinEventQueue::submit( std::size_t machine, eventType type, float value, const callback& done ) {
+  assert( machine < machines.size() );
+
+  // Apply back-pressure instead of letting the queue grow
+  std::deque<event>& events = machines[machine].events;
+  if ( events.size() >= capacity )
+    return false;
+
+  event e = { type, value, done };
+  events.push_back( e );
+  return true;
+}
+
+std::size_t coinEventQueue::runOnce() {
+  std::size_t processed = 0;
+
+  // Handle the events of one machine at a time, so that its state
+  // stays in cache for the whole batch.
+  for ( std::size_t i = 0; i < machines.size(); i++ ) {
+    std::size_t queued = machines[i].events.size();
+    std::size_t count = queued < batchSize ? queued : batchSize;
+
+    for ( std::size_t j = 0; j < count; j++ ) {
+      // Move the event out first: its callback may submit new events
+      event e = std::move( machines[i].events.front() );
+      machines[i].events.pop_front();
+      process( machines[i], e );
+    }
+
+    processed += count;
+  }
+
+  return processed;
+}
+
+std::size_t coinEventQueue::run() {
+  std::size_t processed = 0;
+  std::size_t count;
+
+  while ( ( count = runOnce() ) > 0 )
+    processed += count;
+
+  return processed;
+}
+
+std::size_t coinEventQueue::pending( std::size_t machine ) const {
+  assert( machine < machines.size() );
+  return machines[machine].events.size();
+}
+
+void coinEventQueue::process( machineState& state, const event& e ) {
+  std::vector<coinValue> change;
+  status result = succeeded;
+
+  try {
+    switch ( e.type ) {
+      case addCoinEvent:
+        state.machine->addCoin( e.value );
+        state.creditCents += std::lround( e.value * 100 );
+        break;
+
+      case computeChangeEvent:
+        change = state.machine->computeChange( e.value );
+        break;
+
+      case vendEvent: {
+        long priceCents = std::lround( e.value * 100 );
+        if ( state.creditCents < priceCents ) {
+          result = notEnoughCredit;
+          break;
+        }
+
+        change = state.machine->computeChange( ( state.creditCents - priceCents ) / 100.0f );
+        state.creditCents = 0;
+        break;
+      }
+    }
+  } catch ( vendingMachine::exceptions exception ) {
+    result = exception == vendingMachine::unsupportedCoinException ? unsupportedCoin : notEnoughCoins;
+  }
+
+  if ( e.done )
+    e.done( result, change );
+}
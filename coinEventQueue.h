@@ -0,0 +1,164 @@
+/*
+ * Developed for the VMachine industries.
+ * This product includes software developed by the VMachine industries.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef COIN_EVENT_QUEUE_H
+#define COIN_EVENT_QUEUE_H
+
+#include "vendingMachine.h"
+#include <cstddef>
+#include <vector>
+#include <deque>
+#include <functional>
+
+/**
+ * An asynchronous front end for one or more "vendingMachine" objects.
+ *
+ * Devices (coin acceptors, payout hoppers, payment terminals) submit
+ * addCoin, computeChange and vend events without blocking. The events
+ * are queued per machine and executed on the thread that calls
+ * runOnce() or run(), which processes the queued events of each
+ * machine in batches. The result of every event is passed to the
+ * callback given on submission.
+ *
+ * Each machine queues at most "capacity" events. Submitting to a full
+ * queue fails, so devices that produce events faster than they can be
+ * processed (e.g. a slow payout hopper) have to wait and resubmit.
+ *
+ * Objects of this class are not thread safe: events must be submitted
+ * and processed on the same thread.
+ */
+class coinEventQueue {
+public:
+  /**
+   * @brief The outcome of a processed event.
+   */
+  enum status {
+    /// The event was processed successfully.
+    succeeded,
+    /// addCoin was given a coin the machine does not support.
+    unsupportedCoin,
+    /// computeChange or vend could not find enough coins for the change.
+    notEnoughCoins,
+    /// vend was requested for a price higher than the deposited coins.
+    notEnoughCredit
+  };
+
+  /**
+   * @brief Called once an event has been processed. "change" holds the
+   * returned coins of successful computeChange and vend events, and is
+   * empty otherwise.
+   */
+  typedef std::function<void( status result, const std::vector<coinValue>& change )> callback;
+
+  /**
+   * @brief The default constructor is removed as we require the
+   * queue sizes to be passed at initialisation.
+   */
+  coinEventQueue() = delete;
+
+  /**
+   * @param capacity The maximum number of queued events per machine.
+   *
+   * @param batchSize The maximum number of events of each machine
+   * processed by a single call to runOnce().
+   */
+  coinEventQueue( std::size_t capacity, std::size_t batchSize );
+
+  /**
+   * Registers a machine whose events will be processed by this queue.
+   * The machine must outlive the queue and must not be used directly
+   * while events for it are queued.
+   *
+   * @returns the id used to submit events for "machine".
+   */
+  std::size_t addMachine( vendingMachine& machine );
+
+  /**
+   * Queues a vendingMachine::addCoin() call. Accepted coins are added
+   * to the credit of the machine, to be used by the next vend event.
+   *
+   * @returns false when the queue of the machine is full, in which case
+   * the event is discarded and "done" is never called.
+   */
+  bool addCoin( std::size_t machine, coinValue coin, const callback& done );
+
+  /**
+   * Queues a vendingMachine::computeChange() call.
+   *
+   * @returns false when the queue of the machine is full, in which case
+   * the event is discarded and "done" is never called.
+   */
+  bool computeChange( std::size_t machine, float change, const callback& done );
+
+  /**
+   * Queues the sale of a product costing "price". The credit of the
+   * machine minus "price" is returned as change and the credit is
+   * reset. On failure the credit is kept.
+   *
+   * @returns false when the queue of the machine is full, in which case
+   * the event is discarded and "done" is never called.
+   */
+  bool vend( std::size_t machine, float price, const callback& done );
+
+  /**
+   * Processes up to "batchSize" queued events of every machine, in the
+   * order they were submitted. Callbacks may submit new events.
+   *
+   * @returns the number of events processed.
+   */
+  std::size_t runOnce();
+
+  /**
+   * Calls runOnce() until no events are queued.
+   *
+   * @returns the number of events processed.
+   */
+  std::size_t run();
+
+  /**
+   * @returns the number of events queued for "machine".
+   */
+  std::size_t pending( std::size_t machine ) const;
+
+private:
+  enum eventType { addCoinEvent, computeChangeEvent, vendEvent };
+
+  struct event {
+    eventType type;
+    /// The coin, change or price, depending on "type".
+    float value;
+    callback done;
+  };
+
+  struct machineState {
+    vendingMachine* machine;
+    /// The value in cents of the coins deposited since the last sale.
+    /// Kept as an integer so that it does not drift over many coins.
+    long creditCents;
+    std::deque<event> events;
+  };
+
+  bool submit( std::size_t machine, eventType type, float value, const callback& done );
+  void process( machineState& state, const event& e );
+
+  std::size_t capacity;
+  std::size_t batchSize;
+  std::vector<machineState> machines;
+};
+
+#endif
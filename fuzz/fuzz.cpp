@@ -0,0 +1,37 @@
+/*
+ * Developed for the VMachine industries.
+ * This product includes software developed by the VMachine industries.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "../tests.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+
+/*
+ * libFuzzer entry point. Each input is decoded into a set of coins and
+ * a sequence of addCoin() / computeChange() calls, see
+ * vendingMachineTests::check_operation_sequence(). Any violated
+ * property aborts so that libFuzzer records the input.
+ */
+extern "C" int LLVMFuzzerTestOneInput( const uint8_t* data, size_t size ) {
+  vendingMachineTests tests;
+
+  if ( !tests.check_operation_sequence( data, size ) )
+    abort();
+
+  return 0;
+}
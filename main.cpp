@@ -32,8 +32,9 @@ void runTests() {
   streambuf* errorBuffer = cerr.rdbuf(blackHole.rdbuf());
 
   vendingMachineTests tests;
+  coinEventQueueTests queueTests;
 
-  const int testCount = 13;
+  const int testCount = 23;
   int passedTests = 0;
 
   passedTests += int(tests.test_stored_coins_var_after_object_construction1());
@@ -53,6 +54,18 @@ void runTests() {
   passedTests += int(tests.test_storedCoins_var_after_computeChange_is_called_with_valid_data());
   passedTests += int(tests.test_storedCoins_var_after_computeChange_is_called_with_erronous_data());
 
+  passedTests += int(tests.test_computeChange_against_reference_with_random_canonical_data());
+  passedTests += int(tests.test_computeChange_properties_with_random_data());
+  passedTests += int(tests.test_random_addCoin_and_computeChange_sequences());
+
+  passedTests += int(queueTests.test_events_are_processed_in_submission_order());
+  passedTests += int(queueTests.test_vend_returns_credit_minus_price_as_change());
+  passedTests += int(queueTests.test_vend_with_insufficient_credit());
+  passedTests += int(queueTests.test_submission_fails_when_queue_is_full());
+  passedTests += int(queueTests.test_runOnce_processes_one_batch_per_machine());
+  passedTests += int(queueTests.test_vend_after_many_small_coins());
+  passedTests += int(queueTests.test_simulated_devices_match_synchronous_calls());
+
   std::cout << "Total tests passed: " << passedTests << " / " << testCount << '\n';
   cerr.rdbuf(cerrBuff);
 }
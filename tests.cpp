@@ -19,6 +19,9 @@
 #include "vendingMachine.h"
 #include "tests.h"
 #include <map>
+#include <vector>
+#include <random>
+#include <cmath>
 #include <iostream>
 
 using namespace std;
@@ -314,3 +317,530 @@ bool vendingMachineTests::test_storedCoins_var_after_computeChange_is_called_wit
 
   return validState;
 }
+
+// Randomised tests of computeChange() against a reference solver
+
+// Coins used in these tests are built from whole cent values, so
+// rounding recovers their value in cents exactly.
+static int toCents( coinValue coin ) {
+  return int( std::lround( coin * 100 ) );
+}
+
+// Exhaustive reference solver: returns the least number of coins of
+// "inventory" (cents -> quantity) that sum up to exactly "changeCents",
+// or -1 when no such collection exists.
+static int referenceMinimumCoins( const map<int, unsigned int>& inventory, int changeCents ) {
+  vector<int> minCoins( changeCents + 1, -1 );
+  minCoins[0] = 0;
+
+  // Every stored coin is an item that is either used or not. More than
+  // changeCents / coin copies of a coin can never be used.
+  for ( auto coinPair : inventory ) {
+    int coin = coinPair.first;
+    unsigned int usableCopies = coin > 0 ? changeCents / coin : 0;
+    if ( coinPair.second < usableCopies )
+      usableCopies = coinPair.second;
+
+    for ( unsigned int copy = 0; copy < usableCopies; copy++ )
+      for ( int value = changeCents; value >= coin; value-- ) {
+        int rest = minCoins[value - coin];
+        if ( rest != -1 && ( minCoins[value] == -1 || rest + 1 < minCoins[value] ) )
+          minCoins[value] = rest + 1;
+      }
+  }
+
+  return minCoins[changeCents];
+}
+
+bool vendingMachineTests::check_computeChange_properties( vendingMachine& machine, int changeCents, bool expectOptimal ) {
+  const map<coinValue, unsigned int> storedCoinsBefore = machine.storedCoins;
+
+  map<int, unsigned int> inventory;
+  for ( auto coinPair : storedCoinsBefore )
+    inventory[toCents( coinPair.first )] += coinPair.second;
+
+  int referenceCoins = referenceMinimumCoins( inventory, changeCents );
+
+  vector<coinValue> change;
+
+  try {
+    change = machine.computeChange( changeCents / 100.0f );
+  } catch ( vendingMachine::exceptions e ) {
+    // On failure the coins must be rolled back
+    if ( e != machine.notEnoughCoinsException || machine.storedCoins != storedCoinsBefore )
+      return false;
+
+    // An optimal engine only fails when no collection exists
+    return !( expectOptimal && referenceCoins != -1 );
+  }
+
+  // The returned coins must sum up to exactly the requested change and
+  // must be exactly the coins removed from the machine.
+  map<coinValue, unsigned int> expectedStoredCoins = storedCoinsBefore;
+  int changeSum = 0;
+
+  for ( coinValue coin : change ) {
+    if ( machine.coins.count( coin ) == 0 || expectedStoredCoins[coin] == 0 )
+      return false;
+
+    expectedStoredCoins[coin]--;
+    changeSum += toCents( coin );
+  }
+
+  if ( changeSum != changeCents || machine.storedCoins != expectedStoredCoins )
+    return false;
+
+  // No engine can use fewer coins than the reference
+  if ( referenceCoins == -1 || int( change.size() ) < referenceCoins )
+    return false;
+
+  return !( expectOptimal && int( change.size() ) != referenceCoins );
+}
+
+bool vendingMachineTests::check_operation_sequence( const unsigned char* data, size_t size ) {
+  size_t position = 0;
+  auto nextByte = [&]() -> unsigned int { return position < size ? data[position++] : 0; };
+
+  // Up to 8 coins worth 0.01 to 2.00, with up to 15 of each stored
+  map<coinValue, unsigned int> initialCoins;
+  unsigned int coinCount = nextByte() % 8 + 1;
+
+  for ( unsigned int i = 0; i < coinCount; i++ ) {
+    coinValue coin = ( nextByte() % 200 + 1 ) / 100.0f;
+    initialCoins[coin] = nextByte() % 16;
+  }
+
+  vendingMachine machine( initialCoins );
+  vector<coinValue> coinValues;
+
+  for ( auto coinPair : initialCoins )
+    coinValues.push_back( coinPair.first );
+
+  while ( position < size ) {
+    unsigned int operation = nextByte();
+
+    if ( operation % 2 == 0 ) {
+      // Deposit one of the supported coins, or one worth 3.01 which is
+      // never supported.
+      unsigned int index = nextByte() % ( coinValues.size() + 1 );
+      coinValue coin = index < coinValues.size() ? coinValues[index] : 3.01f;
+
+      map<coinValue, unsigned int> expectedStoredCoins = machine.storedCoins;
+      bool rejected = false;
+
+      try {
+        machine.addCoin( coin );
+      } catch ( vendingMachine::exceptions e ) {
+        if ( e != machine.unsupportedCoinException )
+          return false;
+        rejected = true;
+      }
+
+      if ( rejected != ( index == coinValues.size() ) )
+        return false;
+
+      if ( !rejected )
+        expectedStoredCoins[coin]++;
+
+      if ( machine.storedCoins != expectedStoredCoins )
+        return false;
+    } else {
+      // Request change of up to 9.99
+      unsigned int changeCents = ( nextByte() << 8 | nextByte() ) % 1000;
+
+      if ( !check_computeChange_properties( machine, changeCents, false ) )
+        return false;
+    }
+  }
+
+  return true;
+}
+
+// Greedy change is optimal for the implemented currencies as long as
+// the machine holds enough of every coin.
+bool vendingMachineTests::test_computeChange_against_reference_with_random_canonical_data() {
+  const vector<currency> currencies = { GBP, EUR, USD };
+  const vector<vector<int>> coinCents = { {1, 2, 5, 10, 20, 50, 100, 200},
+                                          {1, 2, 5, 10, 20, 50, 100, 200},
+                                          {1, 5, 10, 25} };
+
+  mt19937 generator( 2020 );
+  uniform_int_distribution<int> currencyDist( 0, currencies.size() - 1 );
+  uniform_int_distribution<int> changeDist( 0, 500 );
+  uniform_int_distribution<unsigned int> extraCoinsDist( 0, 3 );
+
+  for ( int iteration = 0; iteration < 2000; iteration++ ) {
+    int c = currencyDist( generator );
+    int changeCents = changeDist( generator );
+
+    vector<unsigned int> coinQuantities;
+    for ( int cents : coinCents[c] )
+      coinQuantities.push_back( changeCents / cents + extraCoinsDist( generator ) );
+
+    vendingMachine myVendMachine( currencies[c], coinQuantities );
+
+    if ( !check_computeChange_properties( myVendMachine, changeCents, true ) ) {
+      cout << "ERROR: Test test_computeChange_against_reference_with_random_canonical_data failed." << endl;
+      return false;
+    }
+  }
+
+  return true;
+}
+
+// Arbitrary coins and quantities, for which greedy change may fail or
+// use more coins than needed.
+bool vendingMachineTests::test_computeChange_properties_with_random_data() {
+  mt19937 generator( 2021 );
+  uniform_int_distribution<int> coinCountDist( 1, 6 );
+  uniform_int_distribution<int> coinCentsDist( 1, 200 );
+  uniform_int_distribution<unsigned int> quantityDist( 0, 10 );
+  uniform_int_distribution<int> changeDist( 0, 500 );
+
+  for ( int iteration = 0; iteration < 2000; iteration++ ) {
+    vector<coinValue> coinValues;
+    vector<unsigned int> coinQuantities;
+
+    for ( int i = coinCountDist( generator ); i > 0; i-- ) {
+      coinValues.push_back( coinCentsDist( generator ) / 100.0f );
+      coinQuantities.push_back( quantityDist( generator ) );
+    }
+
+    vendingMachine myVendMachine = buildVendMachine( coinValues, coinQuantities );
+
+    if ( !check_computeChange_properties( myVendMachine, changeDist( generator ), false ) ) {
+      cout << "ERROR: Test test_computeChange_properties_with_random_data failed." << endl;
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool vendingMachineTests::test_random_addCoin_and_computeChange_sequences() {
+  mt19937 generator( 2022 );
+  uniform_int_distribution<int> lengthDist( 0, 64 );
+  uniform_int_distribution<int> byteDist( 0, 255 );
+
+  for ( int iteration = 0; iteration < 500; iteration++ ) {
+    vector<unsigned char> data( lengthDist( generator ) );
+    for ( auto& byte : data )
+      byte = byteDist( generator );
+
+    if ( !check_operation_sequence( data.data(), data.size() ) ) {
+      cout << "ERROR: Test test_random_addCoin_and_computeChange_sequences failed." << endl;
+      return false;
+    }
+  }
+
+  return true;
+}
+
+// Class coinEventQueue tests
+
+// Stores the results passed to coinEventQueue callbacks
+struct eventLog {
+  vector<coinEventQueue::status> results;
+  vector<vector<coinValue>> changes;
+
+  coinEventQueue::callback recorder() {
+    return [this]( coinEventQueue::status result, const vector<coinValue>& change ) {
+      results.push_back( result );
+      changes.push_back( change );
+    };
+  }
+};
+
+bool coinEventQueueTests::test_events_are_processed_in_submission_order() {
+  vector<unsigned int> coinQuantities = {20, 20, 20, 50, 50, 50, 100, 100};
+  vendingMachine myVendMachine( GBP, coinQuantities );
+
+  coinEventQueue queue( 16, 16 );
+  size_t machine = queue.addMachine( myVendMachine );
+  eventLog log;
+
+  queue.addCoin( machine, 0.13, log.recorder() );
+  queue.computeChange( machine, 3.26, log.recorder() );
+  queue.addCoin( machine, 2.00, log.recorder() );
+
+  // Nothing runs before the queue is run
+  bool validState = log.results.empty() && queue.pending( machine ) == 3;
+
+  queue.run();
+
+  vector<coinEventQueue::status> expectedResults = { coinEventQueue::unsupportedCoin,
+                                                     coinEventQueue::succeeded,
+                                                     coinEventQueue::succeeded };
+  vector<coinValue> expectedChange = { 2.00, 1.00, 0.20, 0.05, 0.01 };
+
+  validState = validState && log.results == expectedResults && log.changes[1] == expectedChange &&
+               queue.pending( machine ) == 0;
+
+  if ( !validState )
+    cout << "ERROR: Test test_events_are_processed_in_submission_order failed." << endl;
+
+  return validState;
+}
+
+bool coinEventQueueTests::test_vend_returns_credit_minus_price_as_change() {
+  vector<unsigned int> coinQuantities = {20, 20, 20, 50, 50, 50, 100, 100};
+  vendingMachine myVendMachine( GBP, coinQuantities );
+
+  coinEventQueue queue( 16, 16 );
+  size_t machine = queue.addMachine( myVendMachine );
+  eventLog log;
+
+  // Someone gives £1 and £2 for a product costing £1.25, then buys
+  // another one costing £1.25 without any credit.
+  queue.addCoin( machine, 1.00, log.recorder() );
+  queue.addCoin( machine, 2.00, log.recorder() );
+  queue.vend( machine, 1.25, log.recorder() );
+  queue.vend( machine, 1.25, log.recorder() );
+  queue.run();
+
+  vector<coinValue> expectedChange = { 1.00, 0.50, 0.20, 0.05 };
+
+  bool validState = log.results.size() == 4 && log.results[2] == coinEventQueue::succeeded &&
+                    log.changes[2] == expectedChange && log.results[3] == coinEventQueue::notEnoughCredit;
+
+  if ( !validState )
+    cout << "ERROR: Test test_vend_returns_credit_minus_price_as_change failed." << endl;
+
+  return validState;
+}
+
+bool coinEventQueueTests::test_vend_with_insufficient_credit() {
+  vector<unsigned int> coinQuantities = {0, 0, 0, 0, 0, 0, 0, 0};
+  vendingMachine myVendMachine( GBP, coinQuantities );
+
+  coinEventQueue queue( 16, 16 );
+  size_t machine = queue.addMachine( myVendMachine );
+  eventLog log;
+
+  // The credit of £1 is kept when the sale fails, and used by the next
+  // sale.
+  queue.addCoin( machine, 1.00, log.recorder() );
+  queue.vend( machine, 1.20, log.recorder() );
+  queue.vend( machine, 0.50, log.recorder() );
+  queue.vend( machine, 1.00, log.recorder() );
+  queue.run();
+
+  vector<coinEventQueue::status> expectedResults = { coinEventQueue::succeeded,
+                                                     coinEventQueue::notEnoughCredit,
+                                                     coinEventQueue::notEnoughCoins,
+                                                     coinEventQueue::succeeded };
+
+  bool validState = log.results == expectedResults && log.changes[3].empty();
+
+  if ( !validState )
+    cout << "ERROR: Test test_vend_with_insufficient_credit failed." << endl;
+
+  return validState;
+}
+
+bool coinEventQueueTests::test_submission_fails_when_queue_is_full() {
+  vector<unsigned int> coinQuantities = {20, 40, 80, 80};
+  vendingMachine myVendMachine( USD, coinQuantities );
+
+  coinEventQueue queue( 2, 1 );
+  size_t machine = queue.addMachine( myVendMachine );
+  eventLog log;
+
+  bool validState = queue.computeChange( machine, 0.30, log.recorder() ) &&
+                    queue.computeChange( machine, 0.30, log.recorder() ) &&
+                    !queue.computeChange( machine, 0.30, log.recorder() );
+
+  // Processing one event makes room for another one
+  validState = validState && queue.runOnce() == 1 && queue.computeChange( machine, 0.30, log.recorder() );
+
+  validState = validState && queue.run() == 2 && log.results.size() == 3;
+
+  if ( !validState )
+    cout << "ERROR: Test test_submission_fails_when_queue_is_full failed." << endl;
+
+  return validState;
+}
+
+bool coinEventQueueTests::test_runOnce_processes_one_batch_per_machine() {
+  vector<unsigned int> coinQuantities = {20, 40, 80, 80};
+  vendingMachine firstVendMachine( USD, coinQuantities );
+  vendingMachine secondVendMachine( USD, coinQuantities );
+
+  coinEventQueue queue( 16, 2 );
+  size_t first = queue.addMachine( firstVendMachine );
+  size_t second = queue.addMachine( secondVendMachine );
+
+  for ( int i = 0; i < 3; i++ ) {
+    queue.addCoin( first, 0.25, coinEventQueue::callback() );
+    queue.addCoin( second, 0.25, coinEventQueue::callback() );
+  }
+
+  bool validState = queue.runOnce() == 4 && queue.pending( first ) == 1 && queue.pending( second ) == 1 &&
+                    queue.runOnce() == 2 && queue.runOnce() == 0;
+
+  if ( !validState )
+    cout << "ERROR: Test test_runOnce_processes_one_batch_per_machine failed." << endl;
+
+  return validState;
+}
+
+// Regression test: the credit must not drift when it is built up from
+// many small coins.
+bool coinEventQueueTests::test_vend_after_many_small_coins() {
+  vector<unsigned int> coinQuantities = {0, 0, 0, 0, 0, 0, 0, 0};
+  vendingMachine myVendMachine( GBP, coinQuantities );
+
+  coinEventQueue queue( 1000, 1000 );
+  size_t machine = queue.addMachine( myVendMachine );
+  eventLog log;
+
+  // 40 x £0.10 for a product costing exactly £4
+  for ( int i = 0; i < 40; i++ )
+    queue.addCoin( machine, 0.10, coinEventQueue::callback() );
+  queue.vend( machine, 4.00, log.recorder() );
+
+  // 500 x £0.01 for a product costing £4.99
+  for ( int i = 0; i < 500; i++ )
+    queue.addCoin( machine, 0.01, coinEventQueue::callback() );
+  queue.vend( machine, 4.99, log.recorder() );
+
+  queue.run();
+
+  vector<coinEventQueue::status> expectedResults = { coinEventQueue::succeeded, coinEventQueue::succeeded };
+  vector<coinValue> expectedChange = { 0.01 };
+
+  bool validState = log.results == expectedResults && log.changes[0].empty() && log.changes[1] == expectedChange;
+
+  if ( !validState )
+    cout << "ERROR: Test test_vend_after_many_small_coins failed." << endl;
+
+  return validState;
+}
+
+// Every machine has a coin acceptor, a payment terminal and a payout
+// hopper submitting events at random. Devices retry when the queue is
+// full. The results must match those of the same calls made
+// synchronously, in submission order, on an identical machine, with
+// the credit counted in cents.
+bool coinEventQueueTests::test_simulated_devices_match_synchronous_calls() {
+  const size_t machineCount = 3;
+  const vector<unsigned int> coinQuantities = {5, 5, 5, 5, 5, 5, 5, 5};
+  // Mostly small coins, so that the credit of a sale is built up from
+  // many of them. 13 cents is not a valid coin.
+  const vector<int> acceptedCoinCents = {1, 2, 5, 10, 13, 20, 50};
+  const vector<int> priceCents = {45, 125, 210, 399, 400};
+
+  enum device { acceptor, terminal, hopper };
+
+  struct submittedEvent {
+    device type;
+    int cents;
+  };
+
+  mt19937 generator( 2023 );
+  uniform_int_distribution<int> machineDist( 0, machineCount - 1 );
+  // About 30 deposits per sale or change request
+  discrete_distribution<int> deviceDist( { 30, 1, 1 } );
+  uniform_int_distribution<int> executorDist( 0, 9 );
+  uniform_int_distribution<int> coinDist( 0, acceptedCoinCents.size() - 1 );
+  uniform_int_distribution<int> priceDist( 0, priceCents.size() - 1 );
+  uniform_int_distribution<int> changeDist( 1, 150 );
+
+  vector<vendingMachine> machines( machineCount, vendingMachine( GBP, coinQuantities ) );
+  coinEventQueue queue( 8, 4 );
+  vector<vector<submittedEvent>> submitted( machineCount );
+  vector<eventLog> logs( machineCount );
+  // The event each device failed to submit, if any
+  vector<vector<submittedEvent>> retries( 3 * machineCount );
+
+  for ( size_t m = 0; m < machineCount; m++ )
+    queue.addMachine( machines[m] );
+
+  for ( int step = 0; step < 20000; step++ ) {
+    // The executor runs less often than devices submit events
+    if ( executorDist( generator ) == 0 ) {
+      queue.runOnce();
+      continue;
+    }
+
+    size_t m = machineDist( generator );
+    device type = device( deviceDist( generator ) );
+    vector<submittedEvent>& retry = retries[3 * m + type];
+    submittedEvent e = { type, 0 };
+
+    if ( !retry.empty() ) {
+      e = retry.back();
+      retry.pop_back();
+    } else if ( type == acceptor )
+      e.cents = acceptedCoinCents[coinDist( generator )];
+    else if ( type == terminal )
+      e.cents = priceCents[priceDist( generator )];
+    else
+      e.cents = changeDist( generator );
+
+    bool queued;
+    if ( type == acceptor )
+      queued = queue.addCoin( m, e.cents / 100.0f, logs[m].recorder() );
+    else if ( type == terminal )
+      queued = queue.vend( m, e.cents / 100.0f, logs[m].recorder() );
+    else
+      queued = queue.computeChange( m, e.cents / 100.0f, logs[m].recorder() );
+
+    if ( queued )
+      submitted[m].push_back( e );
+    else
+      retry.push_back( e );
+  }
+
+  queue.run();
+
+  bool validState = true;
+  int sales = 0;
+
+  for ( size_t m = 0; m < machineCount && validState; m++ ) {
+    vendingMachine syncVendMachine( GBP, coinQuantities );
+    int creditCents = 0;
+
+    if ( logs[m].results.size() != submitted[m].size() ) {
+      validState = false;
+      break;
+    }
+
+    for ( size_t i = 0; i < submitted[m].size(); i++ ) {
+      const submittedEvent& e = submitted[m][i];
+      coinEventQueue::status expectedResult = coinEventQueue::succeeded;
+      vector<coinValue> expectedChange;
+
+      try {
+        if ( e.type == acceptor ) {
+          syncVendMachine.addCoin( e.cents / 100.0f );
+          creditCents += e.cents;
+        } else if ( e.type == hopper )
+          expectedChange = syncVendMachine.computeChange( e.cents / 100.0f );
+        else if ( creditCents < e.cents )
+          expectedResult = coinEventQueue::notEnoughCredit;
+        else {
+          expectedChange = syncVendMachine.computeChange( ( creditCents - e.cents ) / 100.0f );
+          creditCents = 0;
+          sales++;
+        }
+      } catch ( vendingMachine::exceptions exception ) {
+        expectedResult = exception == vendingMachine::unsupportedCoinException ? coinEventQueue::unsupportedCoin
+                                                                               : coinEventQueue::notEnoughCoins;
+      }
+
+      if ( logs[m].results[i] != expectedResult || logs[m].changes[i] != expectedChange ) {
+        validState = false;
+        break;
+      }
+    }
+  }
+
+  // Make sure the simulation actually exercised sales
+  validState = validState && sales > 0;
+
+  if ( !validState )
+    cout << "ERROR: Test test_simulated_devices_match_synchronous_calls failed." << endl;
+
+  return validState;
+}
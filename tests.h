@@ -19,6 +19,10 @@
 #ifndef TESTS_H
 #define TESTS_H
 
+#include "vendingMachine.h"
+#include "coinEventQueue.h"
+#include <cstddef>
+
 class vendingMachineTests {
 public:
   // Constructor vendingMachine( currency curr, const std::vector<unsigned int>& initialQuantity ) :
@@ -41,6 +45,49 @@ public:
   bool test_return_val_of_computeChange_func_with_erronous_data2();
   bool test_storedCoins_var_after_computeChange_is_called_with_valid_data();
   bool test_storedCoins_var_after_computeChange_is_called_with_erronous_data();
+
+  // Randomised tests of computeChange() against a reference solver:
+  bool test_computeChange_against_reference_with_random_canonical_data();
+  bool test_computeChange_properties_with_random_data();
+  bool test_random_addCoin_and_computeChange_sequences();
+
+  /**
+   * Calls computeChange() on "machine" and checks the properties
+   * every change engine must satisfy: On success the returned coins
+   * sum up to exactly "changeCents" and are removed from storedCoins.
+   * On failure storedCoins is left untouched. The result is also
+   * compared against an exhaustive reference solver. When
+   * "expectOptimal" is set, the engine must succeed if and only if
+   * the reference does, using the same number of coins.
+   *
+   * @returns true when every property holds.
+   */
+  bool check_computeChange_properties( vendingMachine& machine, int changeCents, bool expectOptimal );
+
+  /**
+   * Decodes "data" into a set of coins, their initial quantities and a
+   * sequence of addCoin() / computeChange() calls, and checks the state
+   * of the machine after each call against a model of its coins.
+   * Used both by the randomised tests and by the libFuzzer entry
+   * point in fuzz/fuzz.cpp.
+   *
+   * @returns true when every property holds.
+   */
+  bool check_operation_sequence( const unsigned char* data, std::size_t size );
+};
+
+class coinEventQueueTests {
+public:
+  // Functions addCoin(), computeChange(), vend() and runOnce():
+  bool test_events_are_processed_in_submission_order();
+  bool test_vend_returns_credit_minus_price_as_change();
+  bool test_vend_with_insufficient_credit();
+  bool test_submission_fails_when_queue_is_full();
+  bool test_runOnce_processes_one_batch_per_machine();
+  bool test_vend_after_many_small_coins();
+
+  // Simulated coin acceptors, payment terminals and payout hoppers:
+  bool test_simulated_devices_match_synchronous_calls();
 };
 
 
@@ -73,7 +73,7 @@ void vendingMachine::addCoin( const coinValue coin ) {
     storedCoins[coin]++;
 }
 
-const std::vector<coinValue> vendingMachine::computeChange( float change ) {
+std::vector<coinValue> vendingMachine::computeChange( float change ) {
   std::vector<coinValue> result;
 
   // Use this instead of 0.0 due to float representation precision loss
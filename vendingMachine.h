@@ -122,7 +122,7 @@ public:
    * @throws vendingMachine::exceptions::notEnoughCoinsException is
    *    raised when such a collection could not be computed.
    */
-  const std::vector<coinValue> computeChange( float change );
+  std::vector<coinValue> computeChange( float change );
 
   /**
    * @brief A class that will be used for testing. It is given access